@@ -3,11 +3,19 @@ QT += core gui widgets
 
 INCLUDEPATH += include
 
+HEADERS += include/dividermodel.h
+HEADERS += include/dividerhistory.h
+HEADERS += include/sectorpalettes.h
 HEADERS += include/abstractdividerslider.h
 HEADERS += include/piechartslider.h
+HEADERS += include/multiringslider.h
 HEADERS += example/examplewidget.h
 
+SOURCES += src/dividermodel.cpp
+SOURCES += src/dividerhistory.cpp
+SOURCES += src/sectorpalettes.cpp
 SOURCES += src/abstractdividerslider.cpp
 SOURCES += src/piechartslider.cpp
+SOURCES += src/multiringslider.cpp
 SOURCES += example/examplewidget.cpp
 SOURCES += example/main.cpp
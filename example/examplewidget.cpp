@@ -25,6 +25,7 @@
 #include <QVBoxLayout>
 #include <QSpinBox>
 #include <QLabel>
+#include <QShortcut>
 
 ExampleWidget::ExampleWidget(QWidget *parent) : QWidget(parent)
 {
@@ -37,6 +38,10 @@ ExampleWidget::ExampleWidget(QWidget *parent) : QWidget(parent)
     pie_chart = new PieChartSlider(number_of_dividers, initial_total);
     pie_chart->setFixedSize(300,300);
 
+    for (int i = 0; i < pie_chart->numberOfSectors(); ++i){
+        pie_chart->setSectorLabel(i, QString::number(i + 1));
+    }
+
     /* Make spinboxes for dividers and connect input */
     for (int i = 0; i < pie_chart->numberOfDividers(); ++i){
         divider_inputs.push_back(new QSpinBox);
@@ -88,6 +93,10 @@ ExampleWidget::ExampleWidget(QWidget *parent) : QWidget(parent)
     connect(total, qOverload<int>(&QSpinBox::valueChanged), pie_chart, &PieChartSlider::setTotal);
     connect(pie_chart, &PieChartSlider::totalChanged, total, &QSpinBox::setValue);
 
+    /* Undo and redo of whole drags and edits */
+    connect(new QShortcut(QKeySequence::Undo, this), &QShortcut::activated, pie_chart, &PieChartSlider::undo);
+    connect(new QShortcut(QKeySequence::Redo, this), &QShortcut::activated, pie_chart, &PieChartSlider::redo);
+
     QVBoxLayout* display_total = new QVBoxLayout;
     display_total->addSpacerItem(new QSpacerItem(0,150));
     display_total->addWidget(new QLabel("Total"), 0, Qt::AlignCenter);
@@ -23,51 +23,117 @@
 #ifndef ABSTRACTDIVIDERSLIDER_H
 #define ABSTRACTDIVIDERSLIDER_H
 
+#include "dividerhistory.h"
+#include "dividermodel.h"
+
 #include <QWidget>
 
+class QDataStream;
+
 class AbstractDividerSlider : public QWidget
 {
     Q_OBJECT
 public:
     explicit AbstractDividerSlider(int number_of_dividers = 1, int total = 100, QWidget *parent = nullptr);
 
-    int numberOfDividers() const {return number_of_dividers;}
-    int numberOfSectors() const  {return number_of_dividers + 1;}
+    int numberOfDividers() const {return model.numberOfDividers();}
+    int numberOfSectors() const  {return model.numberOfSectors();}
+
+    int total() const                 {return model.total();}
+    int dividerValue(int index) const {return model.dividerValue(index);}
+    int sectorValue(int index) const  {return model.sectorValue(index);}
+
+    int dividerMaximum(int index) const {return model.dividerMaximum(index);}
+    int dividerMinimum(int index) const {return model.dividerMinimum(index);}
 
-    int total() const                 {return total_value;}
-    int dividerValue(int index) const {return divider_values[index];}
-    int sectorValue(int index) const;
+    /* Compact, versioned binary snapshot of the slider. Restoring applies the whole
+     * state in one step and only emits stateRestored, not the per value signals */
+    QByteArray saveState() const;
+    bool restoreState(const QByteArray& state);
 
-    int dividerMaximum(int index) const;
-    int dividerMinimum(int index) const;
+    /* Splits concatenated snapshots, like a memory mapped file, without copying.
+     * The returned arrays point into data, which has to outlive them */
+    static QVector<QByteArray> splitStates(const QByteArray& data);
+
+    /* Edits between beginEdit and the matching endEdit are undone as one entry,
+     * like a whole drag. Edits outside of a group get an entry each */
+    void beginEdit();
+    void endEdit();
+
+    bool canUndo() const {return history.canUndo();}
+    bool canRedo() const {return history.canRedo();}
+    /* The change capacity is raised to fit an edit of every divider and the total */
+    void setHistoryCapacity(int max_entries, int max_changes);
 
 signals:
     void totalChanged(int value);
     void sectorValueChanged(int index, int value);
     void dividerValueChanged(int index, int value);
+    void stateRestored();
 
 public slots:
     void setTotal(int value);
     void setSectorValue(int index, int value);
     void setDividerValue(int index, int value);
 
+    /* Sets all dividers in one batch. Ignored unless the values are a legal state */
+    void setDividerValues(const QVector<int>& values);
+
+    void undo();
+    void redo();
+
 protected:
     virtual void moveHandles(int index, int value) = 0;
 
+    /* Called once after the state has been replaced, the number of dividers may have changed.
+     * Edits still open at that point have been dropped */
+    virtual void rebuildHandles();
+
+    /* Subclass part of a snapshot, written after the dividing state. readState must
+     * not apply anything unless it succeeds, and accept a stream already at its end */
+    virtual void writeState(QDataStream& stream) const {Q_UNUSED(stream);}
+    virtual bool readState(QDataStream& stream) {Q_UNUSED(stream); return true;}
+
+    /* Called before undo and redo, closes edits the subclass keeps open across events */
+    virtual void finishEdits() {}
+
     void setDividersInRange(int first, int last, int value);
 
     /* Setting a sector as collapsed implies a value of zero and
      * prevents it from blocking divider movement. Automatically unblocked
      * when value changed through setSectorValue */
-    void setSectorCollapsed(int index, bool is_collapsed);
-    bool isSectorCollapsed(int index) const {return sectors_collapsed[index];}
+    void setSectorCollapsed(int index, bool is_collapsed) {model.setSectorCollapsed(index, is_collapsed);}
+    bool isSectorCollapsed(int index) const               {return model.isSectorCollapsed(index);}
 
 private:
-    int total_value;
-    int number_of_dividers;
+    /* Snapshot header: magic, version and payload size */
+    static const quint32 STATE_MAGIC = 0x44535354;
+    static const quint8 STATE_VERSION = 1;
+    static const int STATE_HEADER_SIZE = 9;
+
+    /* Moves the handles and emits the value signals after dividers first to last moved */
+    void reportChanges(int first, int last);
+
+    /* Batched update path, shared by setDividerValues, undo and redo */
+    bool applyDividerValues(int total, const QVector<int>& values);
+
+    /* Remembers the value a divider had when the current edit started */
+    void recordDivider(int index);
+
+    DividerModel model;
+
+    /* A divider moved during the open edit and the value it started from */
+    struct RecordedDivider{
+        int index;
+        int start_value;
+    };
 
-    QVector<int> divider_values;
-    QVector<bool> sectors_collapsed;
+    DividerHistory history;
+    QVector<RecordedDivider> edited_dividers;
+    QVector<bool> divider_recorded;
+    QVector<DividerHistory::Change> pending_changes;
+    int edit_depth = 0;
+    int edit_start_total = 0;
 };
 
 #endif // ABSTRACTDIVIDERSLIDER_H
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2019  Exargon
+ *
+ * This is part of a widget to provide a slider having multiple
+ * parts with a constant sum.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef DIVIDERHISTORY_H
+#define DIVIDERHISTORY_H
+
+#include <QVector>
+
+/* Bounded undo history of a divider set. Every entry only holds the dividers that
+ * changed and by how much, and both the entries and the changes live in ring buffers
+ * allocated on the first push. The oldest entries are dropped when either runs out of space */
+class DividerHistory
+{
+public:
+    struct Change{
+        int index;
+        int delta;
+    };
+
+    /* Index of a change to the total rather than a divider */
+    static const int TOTAL_INDEX = -1;
+
+    explicit DividerHistory(int max_entries = 32, int max_changes = 512);
+
+    void clear();
+
+    /* Makes room for entries of at least this many changes, clears the history if it grows */
+    void reserveChanges(int count);
+
+    bool canUndo() const {return current > 0;}
+    bool canRedo() const {return current < entry_count;}
+
+    /* Adds an entry after the current one, dropping whatever could be redone. The deltas
+     * of older entries depend on it, so the history is cleared when it does not fit */
+    void push(const QVector<Change>& changes);
+
+    /* Steps the current position and fills changes with the entry passed over.
+     * The deltas are to be subtracted when undoing and added when redoing */
+    bool undo(QVector<Change>& changes);
+    bool redo(QVector<Change>& changes);
+
+private:
+    struct Entry{
+        int first_change = 0;
+        int change_count = 0;
+    };
+
+    Entry& entry(int position) {return entries[(entry_begin + position)%entries.size()];}
+    void copyChanges(const Entry& source, QVector<Change>& changes) const;
+    void dropOldest();
+
+    int max_entries;
+    int max_changes;
+
+    QVector<Entry> entries;
+    int entry_begin = 0;
+    int entry_count = 0;
+    int current = 0;
+
+    QVector<Change> change_pool;
+    int change_begin = 0;
+    int change_used = 0;
+};
+
+#endif // DIVIDERHISTORY_H
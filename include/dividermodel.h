@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2019  Exargon
+ *
+ * This is part of a widget to provide a slider having multiple
+ * parts with a constant sum.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#ifndef DIVIDERMODEL_H
+#define DIVIDERMODEL_H
+
+#include <QVector>
+
+/* The dividing logic of a dividerslider, without any signaling or visuals.
+ * Shared by the sliders so that several divider sets can live in one widget */
+class DividerModel
+{
+public:
+    explicit DividerModel(int number_of_dividers = 1, int total = 100);
+
+    int numberOfDividers() const {return number_of_dividers;}
+    int numberOfSectors() const  {return number_of_dividers + 1;}
+
+    int total() const                 {return total_value;}
+    int dividerValue(int index) const {return divider_values[index];}
+    const QVector<int>& dividerValues() const {return divider_values;}
+    int sectorValue(int index) const;
+
+    int dividerMinimum(int index) const;
+    int dividerMaximum(int index) const;
+
+    /* Scales the dividers to the new total. Returns false if nothing changed */
+    bool setTotal(int total);
+
+    /* The range of dividers that moves together with index, as collapsed
+     * sectors do not block divider movement */
+    void linkedDividers(int index, int& first, int& last) const;
+
+    /* Value is clamped to the legal range, and the value used is returned */
+    int setDividersInRange(int first, int last, int value);
+
+    /* The divider, and its value, that gives the sector at index the value passed */
+    void sectorDivider(int index, int value, int& divider, int& divider_value) const;
+
+    /* Reports what moving the dividers first to last changed: each moved divider and the
+     * sectors on both sides of them. The sliders emit their value signals through this */
+    template<typename DividerChanged, typename SectorChanged>
+    void reportChanges(int first, int last, DividerChanged divider_changed, SectorChanged sector_changed) const;
+
+    void setSectorCollapsed(int index, bool is_collapsed) {sectors_collapsed[index] = is_collapsed;}
+    bool isSectorCollapsed(int index) const               {return sectors_collapsed[index];}
+
+    /* Replaces the whole state at once. An inconsistent state, like dividers out of
+     * order or a collapsed sector that is not empty, is rejected and leaves the model untouched */
+    bool setState(int total, const QVector<int>& values, const QVector<bool>& collapsed);
+
+private:
+    int total_value;
+    int number_of_dividers;
+
+    QVector<int> divider_values;
+    QVector<bool> sectors_collapsed;
+};
+
+template<typename DividerChanged, typename SectorChanged>
+void DividerModel::reportChanges(int first, int last, DividerChanged divider_changed, SectorChanged sector_changed) const{
+    for (int i = first; i <= last; ++i){
+        divider_changed(i, divider_values[i]);
+        sector_changed(i, sectorValue(i));
+    }
+    sector_changed(last + 1, sectorValue(last + 1));
+}
+
+#endif // DIVIDERMODEL_H
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2019  Exargon
+ *
+ * This is part of a widget to provide a slider having multiple
+ * parts with a constant sum.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef MULTIRINGSLIDER_H
+#define MULTIRINGSLIDER_H
+
+#include "dividermodel.h"
+
+#include <QPixmap>
+#include <QWidget>
+
+/* Concentric rings of dividers drawn as one donut chart. Each ring is an independent
+ * divider set, and a ring can be constrained to a sector of a parent ring, in which case
+ * it is drawn within that sector one level further out. Useful for hierarchies */
+class MultiRingSlider : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MultiRingSlider(QWidget *parent = nullptr);
+
+    /* Adds a full circle ring at level and returns its index, or -1 if
+     * the level is already used by another ring */
+    int addRing(int number_of_dividers = 1, int total = 100, int level = 0);
+
+    /* Adds a ring drawn within a sector of parent_ring, one level further out. Returns
+     * its index, or -1 if the parent or sector does not exist or already has a ring */
+    int addChildRing(int parent_ring, int parent_sector, int number_of_dividers = 1, int total = 100);
+
+    int numberOfRings() const  {return rings.size();}
+    int numberOfLevels() const {return rings_by_level.size();}
+
+    int ringLevel(int ring) const    {return rings[ring].level;}
+    int parentRing(int ring) const   {return rings[ring].parent_ring;}
+    int parentSector(int ring) const {return rings[ring].parent_sector;}
+
+    int numberOfDividers(int ring) const {return rings[ring].model.numberOfDividers();}
+    int numberOfSectors(int ring) const  {return rings[ring].model.numberOfSectors();}
+
+    int total(int ring) const                    {return rings[ring].model.total();}
+    int dividerValue(int ring, int index) const {return rings[ring].model.dividerValue(index);}
+    int sectorValue(int ring, int index) const  {return rings[ring].model.sectorValue(index);}
+
+    QColor sectorColor(int ring, int index) const;
+
+    void setPiechartPalette(QVector<QColor> palette)
+        {piechart_palette = palette; layer_dirty = true; update();}
+
+signals:
+    void totalChanged(int ring, int value);
+    void sectorValueChanged(int ring, int index, int value);
+    void dividerValueChanged(int ring, int index, int value);
+
+public slots:
+    void setTotal(int ring, int value);
+    void setSectorValue(int ring, int index, int value);
+    void setDividerValue(int ring, int index, int value);
+
+protected:
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    /* Internal types */
+    struct Ring{
+        DividerModel model;
+
+        int level = 0;
+        int parent_ring = -1;
+        int parent_sector = 0;
+        QVector<int> children;
+
+        /* Cached angular extent of the ring, follows the parent sector */
+        qreal start_angle = 0;
+        qreal span_angle = 0;
+    };
+
+    /* Part of the layer to render again, an angular range from a level outwards */
+    struct DirtyRange{
+        int level;
+        qreal start_angle;
+        qreal end_angle;
+    };
+
+    static const int HANDLE_SIZE = 16;
+    static const int MAX_DIRTY_RANGES = 32;
+
+    int insertRing(const Ring& ring);
+
+    /* Properties */
+    QPoint pieCentre() const {return QPoint(width()/2, height()/2);}
+    int radius() const;
+    qreal innerRadius(int level) const;
+    qreal outerRadius(int level) const;
+
+    /* Convertion functions */
+    qreal dividerAngle(int ring, int index) const;
+    qreal sectorStart(int ring, int sector) const;
+    qreal sectorEnd(int ring, int sector) const;
+    int angleToValue(int ring, qreal angle) const;
+
+    QPointF angleToPosition(qreal angle, qreal radius) const;
+    qreal positionToAngle(QPoint pos) const;
+
+    /* Hit-testing */
+    int levelAt(QPoint pos) const;
+    int ringAt(int level, qreal angle) const;
+    int dividerAt(int ring, QPoint pos) const;
+
+    /* Updates the spans of the rings below the sectors first to last of ring,
+     * and marks that part of the chart to be rendered again */
+    void sectorsChanged(int ring, int first, int last);
+    void updateSpans(int ring);
+
+    /* Emits the value signals after dividers first to last of ring moved */
+    void reportChanges(int ring, int first, int last);
+
+    /* Layout and painting helpers */
+    void renderLayer();
+    void renderRange(const DirtyRange& range);
+    void drawRing(QPainter& painter, int ring, qreal start_angle, qreal end_angle) const;
+    void drawOutlines(QPainter& painter) const;
+
+    /*from Qt definition of 16 ticks per degree*/
+    static const int ANGLE_TICKS_IN_CIRCLE = 360*16;
+
+    QVector<QColor> piechart_palette;
+
+    QVector<Ring> rings;
+    QVector<QVector<int>> rings_by_level;
+
+    /* All rings share one cached layer. Changes only render the affected part again */
+    QPixmap ring_layer;
+    bool layer_dirty = true;
+    QVector<DirtyRange> dirty_ranges;
+
+    int pressed_ring = -1;
+    int pressed_divider = -1;
+};
+
+#endif // MULTIRINGSLIDER_H
@@ -24,29 +24,91 @@
 #define PIECHARTSLIDER_H
 
 #include "abstractdividerslider.h"
+#include "sectorpalettes.h"
+
+#include <QPixmap>
+#include <QStaticText>
+#include <QTimer>
+#include <QTransform>
+
+class QPainter;
 
 class PieChartSlider : public AbstractDividerSlider
 {
     Q_OBJECT
 
 public:
+    /* Draft rendering drops antialiasing and handle outlines. It is only used while
+     * the user interacts, a full quality repaint follows once input has been idle */
+    enum RenderPolicy {
+        AlwaysHighQuality,
+        DraftWhileInteracting,
+        DraftAboveSectorCount
+    };
+    Q_ENUM(RenderPolicy)
+
     explicit PieChartSlider(int number_of_dividers = 1, int total = 100, QWidget *parent = nullptr);
 
     QColor sectorColor(int index) const
         {return piechart_palette[index%piechart_palette.size()];}
 
     void setPiechartPalette(QVector<QColor> palette)
-        {piechart_palette = palette;}
+        {piechart_palette = palette; palette_id = -1; pie_layer_dirty = true; update();}
+
+    /* Palettes registered with SectorPalettes are saved by id. A palette set
+     * directly has id -1 and is left unchanged on restore, as are unknown ids */
+    void setPiechartPalette(int id);
+    int piechartPaletteId() const {return palette_id;}
+
+    int zeroAngle() const {return zero_angle;}
+
+    QString sectorLabel(int index) const
+        {return sector_labels[index].text.text();}
+
+    /* Labels are laid out once and cached, they are only placed again
+     * when the text, the font or the angle of a wedge changes. The pie
+     * shrinks to leave room for the largest label outside of its rim */
+    void setSectorLabel(int index, const QString& label);
+
+    RenderPolicy renderPolicy() const {return render_policy;}
+    void setRenderPolicy(RenderPolicy policy);
+
+    /* Used by DraftAboveSectorCount, draft rendering needs more sectors than this */
+    int draftSectorThreshold() const {return draft_sector_threshold;}
+    void setDraftSectorThreshold(int sectors) {draft_sector_threshold = sectors;}
+
+    /* Milliseconds without input before repainting in full quality */
+    int idleRepaintDelay() const {return idle_timer.interval();}
+    void setIdleRepaintDelay(int msec) {idle_timer.setInterval(msec);}
+
+    /* Duration of the last paintEvent in nanoseconds */
+    qint64 lastPaintTime() const {return last_paint_time;}
+
+signals:
+    void zeroAngleChanged(int angle);
+
+public slots:
+    /* Rotates the whole chart, the values of the dividers are not affected */
+    void setZeroAngle(int angle);
 
 protected:
     void mousePressEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
 
     void wheelEvent(QWheelEvent *even) override;
 
     void paintEvent(QPaintEvent *event) override;
 
+    void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
+
+    void rebuildHandles() override;
+    void finishEdits() override;
+    void writeState(QDataStream& stream) const override;
+    bool readState(QDataStream& stream) override;
+
 private:
     /* Internal types */
     struct Handle{
@@ -58,7 +120,7 @@ private:
             {return 0;}
 
         bool is_pressed = false;
-        int angle = 0;
+        qreal angle = 0;
     };
 
     struct DividerHandle : public Handle{
@@ -74,6 +136,23 @@ private:
         bool visible = false;
     };
 
+    /* Sits halfway to the centre, away from the handles stacking at zero on the rim */
+    struct ZeroHandle : public Handle{
+        int size() const override {return DividerHandle::SIZE;}
+        qreal radiusOffset() const override
+            {return radius_offset;}
+
+        qreal radius_offset = 0;
+    };
+
+    struct SectorLabel{
+        QStaticText text;
+        QPointF centre;
+
+        bool inside = true;
+        bool visible = false;
+    };
+
     /* Handle handling */
     void moveHandles(int index, int value) override;
     void updateSectorHandels(int index, int value);
@@ -83,15 +162,25 @@ private:
     int radius() const;
 
     /* Convertion functions */
-    int valueToAngle (int value) const;
-    int angleToValue (int angle) const;
+    /* Angles are kept in fractional ticks, so every value has its own angle even
+     * when the total is larger than the number of ticks in a circle */
+    qreal valueToAngle (int value) const;
+    int angleToValue (qreal angle) const;
+
+    QPointF angleToPosition(qreal angle, qreal radius) const;
+    qreal positionToAngle(QPoint pos) const;
 
-    QPointF angleToPosition(int angle, qreal radius) const;
-    int positionToAngle(QPoint pos) const;
+    /* Position in the unrotated frame used by the pie layer, handles and labels.
+     * zeroRotation() maps it to the widget */
+    QPointF localPosition(qreal angle, qreal radius) const;
+    QTransform zeroRotation() const;
 
     /* Mouse input processing */
     void processSectorMouseInput(int index, QPoint mouse_pos);
-    int angleFromMouse(int index, QPoint mouse_pos) const;
+    qreal angleFromMouse(int index, QPoint mouse_pos) const;
+
+    void flushWheel();
+    void endWheelBurst();
 
     void setDividerValueFromMouse(int index, QPoint mouse_pos);
     int stabilizedValue(int min_index, int max_index, int value) const;
@@ -100,21 +189,69 @@ private:
 
     void setEmptySectorsCollapsed();
 
+    /* Ends a drag, also when the release was lost to another window or a hidden widget */
+    void releaseHandles();
+
     /* Painting helpers */
     QRectF boundingRect(const Handle& handle) const;
+    QRect repaintRect(const Handle& handle) const;
+
+    void renderPieLayer();
+    void drawPie(QPainter& painter) const;
+
+    /* Render quality */
+    bool isDraft() const;
+    void beginInteraction();
+    void endInteraction();
+    void finishInteraction();
+
+    /* Label placement */
+    void updateLabelLayout();
+    void updateLabelMargin();
 
     /*from Qt definition of 16 ticks per degree*/
     static const int ANGLE_TICKS_IN_CIRCLE = 360*16;
 
-    //Left here to enable future use of the zero/total divider
     int zero_angle = 0;
+    ZeroHandle zero_handle;
 
     QVector<QColor> piechart_palette;
+    int palette_id = SectorPalettes::DEFAULT_PALETTE;
 
     QVector<DividerHandle> divider_handles;
     QVector<SectorHandle> sector_handles;
 
-    int handle_start_angle;
+    QVector<SectorLabel> sector_labels;
+    bool labels_dirty = true;
+    int label_margin = 0;
+
+    /* Wedges, outline and divider lines, drawn unrotated and only rebuilt when they change.
+     * It serves rotation and repaints of handles and labels, not dividers being dragged */
+    QPixmap pie_layer;
+    bool pie_layer_dirty = true;
+    bool pie_layer_draft = false;
+
+    RenderPolicy render_policy = AlwaysHighQuality;
+    int draft_sector_threshold = 50;
+    bool interacting = false;
+    QTimer idle_timer;
+    qint64 last_paint_time = 0;
+
+    qreal handle_start_angle;
+    bool mouse_edit = false;
+
+    /* Wheel input is accumulated in value units and applied once per frame */
+    QTimer wheel_timer;
+    qreal wheel_accumulator = 0;
+    int wheel_sector = -1;
+
+    /* Raw wheel angle short of a whole notch, in eighths of a degree like QWheelEvent */
+    static const int WHEEL_NOTCH = 120;
+    int wheel_angle = 0;
+
+    /* A burst of wheel events is undone as one edit, it ends after a pause in the input */
+    QTimer wheel_burst_timer;
+    bool wheel_burst = false;
 };
 
 #endif // PIECHARTSLIDER_H
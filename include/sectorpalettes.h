@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2019  Exargon
+ *
+ * This is part of a widget to provide a slider having multiple
+ * parts with a constant sum.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef SECTORPALETTES_H
+#define SECTORPALETTES_H
+
+#include <QColor>
+#include <QVector>
+
+/* Process wide list of sector palettes, shared by the sliders. Palettes are
+ * referenced by id in saved states, palette 0 is the default */
+class SectorPalettes
+{
+public:
+    static const int DEFAULT_PALETTE = 0;
+
+    static int registerPalette(const QVector<QColor>& palette);
+
+    /* An empty palette for unknown ids */
+    static QVector<QColor> palette(int id) {return registry().value(id);}
+    static bool contains(int id) {return id >= 0 && id < registry().size();}
+
+private:
+    static QVector<QVector<QColor>>& registry();
+};
+
+#endif // SECTORPALETTES_H
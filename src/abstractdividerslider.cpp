@@ -22,108 +22,310 @@
 
 #include "abstractdividerslider.h"
 
-#include <QtMath>
+#include <QDataStream>
+#include <QtEndian>
 
 AbstractDividerSlider::AbstractDividerSlider(int number_of_dividers, int total, QWidget *parent)
-    : QWidget(parent), total_value(total), number_of_dividers(number_of_dividers)
+    : QWidget(parent), model(number_of_dividers, total)
 {
-    /* Round for more equal dividing at low total_value */
-    int divider_spacing = static_cast<int>(round(static_cast<qreal>(total_value) / numberOfSectors()));
-
-    for (int i = 1; i <= number_of_dividers; ++i){
-        divider_values.push_back(std::min(i*divider_spacing, total_value));
-    }
+    divider_recorded.fill(false, numberOfDividers());
+    edited_dividers.reserve(numberOfDividers());
+    pending_changes.reserve(numberOfDividers() + 1);
+    history.reserveChanges(numberOfDividers() + 1);
+}
 
-    sectors_collapsed.fill(false,numberOfSectors());
+void AbstractDividerSlider::setHistoryCapacity(int max_entries, int max_changes){
+    history = DividerHistory(max_entries, max_changes);
+    history.reserveChanges(numberOfDividers() + 1);
 }
 
 void AbstractDividerSlider::setTotal(int total){
-    if (total == total_value || total < 1) return;
+    if (total == model.total() || total < 1) return;
+    beginEdit();
 
-    qreal ratio = static_cast<qreal>(total)/total_value;
-    total_value = total;
-
-    for (int index = 0; index < number_of_dividers; ++index){
-        divider_values[index] = static_cast<int>(std::round(divider_values[index]*ratio));
-        emit dividerValueChanged(index, divider_values[index]);
-        moveHandles(index, divider_values[index]);
-    }
-    for (int index = 0; index < numberOfSectors(); ++index){
-        emit sectorValueChanged(index, sectorValue(index));
+    for (int index = 0; index < numberOfDividers(); ++index){
+        recordDivider(index);
     }
+    model.setTotal(total);
+    reportChanges(0, numberOfDividers() - 1);
 
     emit totalChanged(total);
     update();
+    endEdit();
 }
 
 void AbstractDividerSlider::setDividerValue(int index, int value){
     if (value == dividerValue(index)) return;
+    beginEdit();
 
-    int min = index;
-    for (; min > 0 && sectors_collapsed[min]; --min);
-    int max = index;
-    for (; max < numberOfDividers() - 1 && sectors_collapsed[max + 1]; ++max);
+    int min, max;
+    model.linkedDividers(index, min, max);
 
     setDividersInRange(min, max, value);
     update();
+    endEdit();
 }
 
 void AbstractDividerSlider::setDividersInRange(int first, int last, int value){
-    int minimum = dividerMinimum(first);
-    int maximum = dividerMaximum(last);
+    for (int i = first; i <= last; ++i){
+        recordDivider(i);
+    }
+
+    model.setDividersInRange(first, last, value);
+    reportChanges(first, last);
+}
 
-    if (value < minimum){
-        value = minimum;
+void AbstractDividerSlider::reportChanges(int first, int last){
+    model.reportChanges(first, last,
+        [this](int index, int value){moveHandles(index, value); emit dividerValueChanged(index, value);},
+        [this](int index, int value){emit sectorValueChanged(index, value);});
+}
+
+void AbstractDividerSlider::setDividerValues(const QVector<int>& values){
+    beginEdit();
+    applyDividerValues(total(), values);
+    endEdit();
+}
+
+bool AbstractDividerSlider::applyDividerValues(int total, const QVector<int>& values){
+    if (values.size() != numberOfDividers()) return false;
+
+    QVector<int> old_values = model.dividerValues();
+    int old_total = model.total();
 
-    } else if (value > maximum){
-        value = maximum;
+    /* Collapsing only applies to sectors that stay empty */
+    QVector<bool> collapsed(numberOfSectors());
+    for (int index = 0; index < numberOfSectors(); ++index){
+        int start = (index == 0)? 0 : values[index - 1];
+        int end = (index == numberOfDividers())? total : values[index];
+        collapsed[index] = isSectorCollapsed(index) && start == end;
     }
 
-    for (int i = first; i <= last; ++i){
-        divider_values[i] = value;
+    for (int index = 0; index < numberOfDividers(); ++index){
+        if (values[index] != old_values[index]){
+            recordDivider(index);
+        }
     }
+    if (!model.setState(total, values, collapsed)) return false;
 
-    for (int i = first; i <= last; ++i){
-        moveHandles(i, value);
-        emit dividerValueChanged(i, value);
-        emit sectorValueChanged(i, sectorValue(i));
+    for (int index = 0; index < numberOfDividers(); ++index){
+        if (values[index] != old_values[index]){
+            moveHandles(index, values[index]);
+            emit dividerValueChanged(index, values[index]);
+        }
+    }
+    for (int index = 0; index < numberOfSectors(); ++index){
+        int start = (index == 0)? 0 : old_values[index - 1];
+        int end = (index == numberOfDividers())? old_total : old_values[index];
+        if (end - start != sectorValue(index)){
+            emit sectorValueChanged(index, sectorValue(index));
+        }
     }
-    emit sectorValueChanged(last + 1, maximum - value);
+    if (total != old_total){
+        emit totalChanged(total);
+    }
+
+    update();
+    return true;
 }
 
-int AbstractDividerSlider::dividerMinimum(int index) const{
-    for (; index > 0 && sectors_collapsed[index]; --index);
-    return (index == 0) ? 0 : divider_values[index - 1];
+void AbstractDividerSlider::beginEdit(){
+    if (edit_depth++ == 0){
+        edit_start_total = total();
+    }
 }
 
-int AbstractDividerSlider::dividerMaximum(int index) const{
-    for (; index < numberOfDividers() - 1 && sectors_collapsed[index + 1]; ++index);
-    return (index == numberOfDividers() - 1) ? total_value : divider_values[index + 1];
+void AbstractDividerSlider::endEdit(){
+    if (edit_depth == 0 || --edit_depth > 0) return;
+
+    /* Turn the recorded start values into deltas, dropping dividers that ended where they started */
+    pending_changes.resize(0);
+    for (const RecordedDivider& recorded : edited_dividers){
+        divider_recorded[recorded.index] = false;
+
+        int delta = dividerValue(recorded.index) - recorded.start_value;
+        if (delta != 0){
+            pending_changes.push_back({recorded.index, delta});
+        }
+    }
+    edited_dividers.resize(0);
+
+    if (total() != edit_start_total){
+        pending_changes.push_back({DividerHistory::TOTAL_INDEX, total() - edit_start_total});
+    }
+
+    history.push(pending_changes);
 }
 
-void AbstractDividerSlider::setSectorValue(int index, int value){
-    if (value == sectorValue(index)) return;
-    sectors_collapsed[index] = false;
+void AbstractDividerSlider::recordDivider(int index){
+    if (edit_depth == 0 || divider_recorded[index]) return;
+
+    divider_recorded[index] = true;
+    edited_dividers.push_back({index, dividerValue(index)});
+}
+
+void AbstractDividerSlider::undo(){
+    finishEdits();
+
+    QVector<DividerHistory::Change> changes;
+    if (edit_depth > 0 || !history.undo(changes)) return;
+
+    QVector<int> values = model.dividerValues();
+    int previous_total = total();
+    for (const DividerHistory::Change& change : changes){
+        if (change.index == DividerHistory::TOTAL_INDEX){
+            previous_total -= change.delta;
+        } else {
+            values[change.index] -= change.delta;
+        }
+    }
+    /* Keep the position in step with the state if the entry no longer applies */
+    if (!applyDividerValues(previous_total, values)){
+        history.redo(changes);
+    }
+}
+
+void AbstractDividerSlider::redo(){
+    finishEdits();
+
+    QVector<DividerHistory::Change> changes;
+    if (edit_depth > 0 || !history.redo(changes)) return;
+
+    QVector<int> values = model.dividerValues();
+    int next_total = total();
+    for (const DividerHistory::Change& change : changes){
+        if (change.index == DividerHistory::TOTAL_INDEX){
+            next_total += change.delta;
+        } else {
+            values[change.index] += change.delta;
+        }
+    }
+    if (!applyDividerValues(next_total, values)){
+        history.undo(changes);
+    }
+}
 
-    if (index == number_of_dividers){
-        setDividerValue(index - 1, total_value - value);
-    } else if (index == 0){
-        setDividerValue(index, value);
-    } else {     
-        setDividerValue(index, divider_values[index - 1] + value);
+void AbstractDividerSlider::rebuildHandles(){
+    for (int index = 0; index < numberOfDividers(); ++index){
+        moveHandles(index, dividerValue(index));
     }
 }
 
-int AbstractDividerSlider::sectorValue(int index) const{
-    if (index == 0){
-        return divider_values[index];
-    } else if (index == number_of_dividers){
-        return total_value - divider_values[index - 1];
-    } else {
-        return divider_values[index] - divider_values[index - 1];
+QByteArray AbstractDividerSlider::saveState() const{
+    QByteArray payload;
+    {
+        QDataStream stream(&payload, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_5_0);
+
+        stream << static_cast<qint32>(total()) << static_cast<qint32>(numberOfDividers());
+        for (int index = 0; index < numberOfDividers(); ++index){
+            stream << static_cast<qint32>(dividerValue(index));
+        }
+
+        /* Collapsed flags packed as bits */
+        QByteArray collapsed((numberOfSectors() + 7)/8, 0);
+        for (int index = 0; index < numberOfSectors(); ++index){
+            if (isSectorCollapsed(index)){
+                collapsed[index/8] = static_cast<char>(collapsed[index/8] | (1 << index%8));
+            }
+        }
+        stream.writeRawData(collapsed.constData(), collapsed.size());
+
+        writeState(stream);
     }
+
+    QByteArray state;
+    QDataStream stream(&state, QIODevice::WriteOnly);
+    stream << STATE_MAGIC << STATE_VERSION << static_cast<quint32>(payload.size());
+    stream.writeRawData(payload.constData(), payload.size());
+    return state;
 }
 
-void AbstractDividerSlider::setSectorCollapsed(int index, bool is_collapsed){
-    sectors_collapsed[index] = is_collapsed;
+bool AbstractDividerSlider::restoreState(const QByteArray& state){
+    if (state.size() < STATE_HEADER_SIZE) return false;
+
+    quint32 magic, size;
+    quint8 version;
+    QDataStream header(state);
+    header >> magic >> version >> size;
+
+    if (magic != STATE_MAGIC || version == 0 || version > STATE_VERSION ||
+            size > static_cast<quint32>(state.size() - STATE_HEADER_SIZE)){
+        return false;
+    }
+
+    QByteArray payload = QByteArray::fromRawData(state.constData() + STATE_HEADER_SIZE, static_cast<int>(size));
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    qint32 stored_total, number_of_dividers;
+    stream >> stored_total >> number_of_dividers;
+    if (stream.status() != QDataStream::Ok || number_of_dividers < 1 ||
+            number_of_dividers > payload.size()/4){
+        return false;
+    }
+
+    QVector<int> values(number_of_dividers);
+    for (int& value : values){
+        qint32 stored;
+        stream >> stored;
+        value = stored;
+    }
+
+    QByteArray collapsed_bits((number_of_dividers + 8)/8, 0);
+    if (stream.readRawData(collapsed_bits.data(), collapsed_bits.size()) != collapsed_bits.size()) return false;
+
+    QVector<bool> collapsed(number_of_dividers + 1);
+    for (int index = 0; index < collapsed.size(); ++index){
+        collapsed[index] = (collapsed_bits[index/8] & (1 << index%8)) != 0;
+    }
+
+    /* Validate everything before applying anything */
+    DividerModel restored;
+    if (stream.status() != QDataStream::Ok || !restored.setState(stored_total, values, collapsed)) return false;
+    if (!readState(stream)) return false;
+
+    model = restored;
+
+    /* Deltas recorded against the old state do not apply anymore, open edits are dropped
+     * and rebuildHandles resets the input of the subclass */
+    history.clear();
+    history.reserveChanges(numberOfDividers() + 1);
+    edited_dividers.resize(0);
+    divider_recorded.fill(false, numberOfDividers());
+    edit_depth = 0;
+    edit_start_total = total();
+
+    rebuildHandles();
+    update();
+
+    emit stateRestored();
+    return true;
+}
+
+QVector<QByteArray> AbstractDividerSlider::splitStates(const QByteArray& data){
+    QVector<QByteArray> states;
+    const uchar* raw = reinterpret_cast<const uchar*>(data.constData());
+
+    int offset = 0;
+    while (data.size() - offset >= STATE_HEADER_SIZE){
+        if (qFromBigEndian<quint32>(raw + offset) != STATE_MAGIC) break;
+
+        quint32 size = qFromBigEndian<quint32>(raw + offset + 5);
+        if (size > static_cast<quint32>(data.size() - offset - STATE_HEADER_SIZE)) break;
+
+        int state_size = STATE_HEADER_SIZE + static_cast<int>(size);
+        states.push_back(QByteArray::fromRawData(data.constData() + offset, state_size));
+        offset += state_size;
+    }
+    return states;
+}
+
+void AbstractDividerSlider::setSectorValue(int index, int value){
+    if (value == sectorValue(index)) return;
+    setSectorCollapsed(index, false);
+
+    int divider, divider_value;
+    model.sectorDivider(index, value, divider, divider_value);
+    setDividerValue(divider, divider_value);
 }
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2019  Exargon
+ *
+ * This is part of a widget to provide a slider having multiple
+ * parts with a constant sum.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+
+#include "dividerhistory.h"
+
+#include <algorithm>
+
+DividerHistory::DividerHistory(int max_entries, int max_changes)
+    : max_entries(std::max(max_entries, 1)), max_changes(std::max(max_changes, 1))
+{
+}
+
+void DividerHistory::clear(){
+    entry_begin = 0;
+    entry_count = 0;
+    current = 0;
+    change_begin = 0;
+    change_used = 0;
+}
+
+void DividerHistory::reserveChanges(int count){
+    if (count <= max_changes) return;
+
+    /* Storage is allocated again by the next push */
+    clear();
+    max_changes = count;
+    entries.clear();
+    change_pool.clear();
+}
+
+void DividerHistory::push(const QVector<Change>& changes){
+    if (changes.isEmpty()) return;
+
+    /* Forget the entries that could have been redone */
+    for (; entry_count > current; --entry_count){
+        change_used -= entry(entry_count - 1).change_count;
+    }
+
+    if (changes.size() > max_changes){
+        clear();
+        return;
+    }
+
+    if (entries.isEmpty()){
+        entries.resize(max_entries);
+        change_pool.resize(max_changes);
+    }
+
+    while (entry_count == entries.size() || change_pool.size() - change_used < changes.size()){
+        dropOldest();
+    }
+
+    Entry& added = entry(entry_count);
+    added.first_change = (change_begin + change_used)%change_pool.size();
+    added.change_count = changes.size();
+
+    for (int i = 0; i < changes.size(); ++i){
+        change_pool[(added.first_change + i)%change_pool.size()] = changes[i];
+    }
+    change_used += changes.size();
+
+    current = ++entry_count;
+}
+
+bool DividerHistory::undo(QVector<Change>& changes){
+    if (!canUndo()) return false;
+
+    copyChanges(entry(--current), changes);
+    return true;
+}
+
+bool DividerHistory::redo(QVector<Change>& changes){
+    if (!canRedo()) return false;
+
+    copyChanges(entry(current++), changes);
+    return true;
+}
+
+void DividerHistory::copyChanges(const Entry& source, QVector<Change>& changes) const{
+    changes.resize(source.change_count);
+    for (int i = 0; i < source.change_count; ++i){
+        changes[i] = change_pool[(source.first_change + i)%change_pool.size()];
+    }
+}
+
+void DividerHistory::dropOldest(){
+    const Entry& oldest = entry(0);
+    change_begin = (change_begin + oldest.change_count)%change_pool.size();
+    change_used -= oldest.change_count;
+
+    entry_begin = (entry_begin + 1)%entries.size();
+    --entry_count;
+    --current;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2019  Exargon
+ *
+ * This is part of a widget to provide a slider having multiple
+ * parts with a constant sum.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+#include "dividermodel.h"
+
+#include <QtMath>
+
+DividerModel::DividerModel(int number_of_dividers, int total)
+    : total_value(total), number_of_dividers(number_of_dividers)
+{
+    /* Round for more equal dividing at low total_value */
+    int divider_spacing = static_cast<int>(round(static_cast<qreal>(total_value) / numberOfSectors()));
+
+    for (int i = 1; i <= number_of_dividers; ++i){
+        divider_values.push_back(std::min(i*divider_spacing, total_value));
+    }
+
+    sectors_collapsed.fill(false,numberOfSectors());
+}
+
+bool DividerModel::setTotal(int total){
+    if (total == total_value || total < 1) return false;
+
+    qreal ratio = static_cast<qreal>(total)/total_value;
+    total_value = total;
+
+    for (int index = 0; index < number_of_dividers; ++index){
+        divider_values[index] = static_cast<int>(std::round(divider_values[index]*ratio));
+    }
+    return true;
+}
+
+bool DividerModel::setState(int total, const QVector<int>& values, const QVector<bool>& collapsed){
+    if (total < 1 || values.isEmpty() || collapsed.size() != values.size() + 1) return false;
+
+    for (int i = 0; i < values.size(); ++i){
+        int minimum = (i == 0)? 0 : values[i - 1];
+        if (values[i] < minimum || values[i] > total) return false;
+    }
+
+    /* Collapsed implies empty, otherwise linkedDividers would chain across the sector */
+    for (int i = 0; i < collapsed.size(); ++i){
+        int start = (i == 0)? 0 : values[i - 1];
+        int end = (i == values.size())? total : values[i];
+        if (collapsed[i] && start != end) return false;
+    }
+
+    total_value = total;
+    number_of_dividers = values.size();
+    divider_values = values;
+    sectors_collapsed = collapsed;
+    return true;
+}
+
+void DividerModel::linkedDividers(int index, int& first, int& last) const{
+    first = index;
+    for (; first > 0 && sectors_collapsed[first]; --first);
+    last = index;
+    for (; last < numberOfDividers() - 1 && sectors_collapsed[last + 1]; ++last);
+}
+
+int DividerModel::setDividersInRange(int first, int last, int value){
+    int minimum = dividerMinimum(first);
+    int maximum = dividerMaximum(last);
+
+    if (value < minimum){
+        value = minimum;
+
+    } else if (value > maximum){
+        value = maximum;
+    }
+
+    for (int i = first; i <= last; ++i){
+        divider_values[i] = value;
+    }
+    return value;
+}
+
+void DividerModel::sectorDivider(int index, int value, int& divider, int& divider_value) const{
+    if (index == number_of_dividers){
+        divider = index - 1;
+        divider_value = total_value - value;
+    } else if (index == 0){
+        divider = index;
+        divider_value = value;
+    } else {
+        divider = index;
+        divider_value = divider_values[index - 1] + value;
+    }
+}
+
+int DividerModel::dividerMinimum(int index) const{
+    for (; index > 0 && sectors_collapsed[index]; --index);
+    return (index == 0) ? 0 : divider_values[index - 1];
+}
+
+int DividerModel::dividerMaximum(int index) const{
+    for (; index < numberOfDividers() - 1 && sectors_collapsed[index + 1]; ++index);
+    return (index == numberOfDividers() - 1) ? total_value : divider_values[index + 1];
+}
+
+int DividerModel::sectorValue(int index) const{
+    if (index == 0){
+        return divider_values[index];
+    } else if (index == number_of_dividers){
+        return total_value - divider_values[index - 1];
+    } else {
+        return divider_values[index] - divider_values[index - 1];
+    }
+}
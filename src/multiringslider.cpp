@@ -0,0 +1,497 @@
+/*
+ * Copyright (C) 2019  Exargon
+ *
+ * This is part of a widget to provide a slider having multiple
+ * parts with a constant sum.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+
+#include "multiringslider.h"
+#include "sectorpalettes.h"
+
+#include <QtMath>
+
+#include <QPainter>
+#include <QPainterPath>
+#include <QStyleOption>
+
+#include <QMouseEvent>
+
+bool anglesOverlap(qreal start1, qreal end1, qreal start2, qreal end2, int ticks_in_circle);
+
+MultiRingSlider::MultiRingSlider(QWidget *parent) : QWidget(parent)
+{
+    setMinimumSize(100,100);
+
+    piechart_palette = SectorPalettes::palette(SectorPalettes::DEFAULT_PALETTE);
+}
+
+int MultiRingSlider::addRing(int number_of_dividers, int total, int level){
+    if (level < 0 || (level < numberOfLevels() && !rings_by_level[level].isEmpty())) return -1;
+
+    Ring ring;
+    ring.model = DividerModel(number_of_dividers, total);
+    ring.level = level;
+    return insertRing(ring);
+}
+
+int MultiRingSlider::addChildRing(int parent_ring, int parent_sector, int number_of_dividers, int total){
+    if (parent_ring < 0 || parent_ring >= numberOfRings()) return -1;
+
+    const Ring& parent = rings[parent_ring];
+    if (parent_sector < 0 || parent_sector >= parent.model.numberOfSectors()) return -1;
+
+    /* A sector holds at most one ring, and full circle rings leave no room at their level */
+    for (int child : parent.children){
+        if (rings[child].parent_sector == parent_sector) return -1;
+    }
+    int level = parent.level + 1;
+    if (level < numberOfLevels()){
+        for (int other : rings_by_level[level]){
+            if (rings[other].parent_ring < 0) return -1;
+        }
+    }
+
+    Ring ring;
+    ring.model = DividerModel(number_of_dividers, total);
+    ring.level = level;
+    ring.parent_ring = parent_ring;
+    ring.parent_sector = parent_sector;
+    return insertRing(ring);
+}
+
+int MultiRingSlider::insertRing(const Ring& ring){
+    int index = rings.size();
+    rings.push_back(ring);
+
+    if (numberOfLevels() <= ring.level){
+        rings_by_level.resize(ring.level + 1);
+    }
+    rings_by_level[ring.level].push_back(index);
+
+    if (ring.parent_ring >= 0){
+        rings[ring.parent_ring].children.push_back(index);
+    }
+    updateSpans(index);
+
+    /* The bands may have changed width, so everything is rendered again */
+    layer_dirty = true;
+    update();
+
+    return index;
+}
+
+void MultiRingSlider::setTotal(int ring, int value){
+    DividerModel& model = rings[ring].model;
+    if (!model.setTotal(value)) return;
+
+    sectorsChanged(ring, 0, model.numberOfDividers());
+    reportChanges(ring, 0, model.numberOfDividers() - 1);
+    emit totalChanged(ring, value);
+}
+
+void MultiRingSlider::setDividerValue(int ring, int index, int value){
+    DividerModel& model = rings[ring].model;
+    if (value == model.dividerValue(index)) return;
+
+    int first, last;
+    model.linkedDividers(index, first, last);
+    model.setDividersInRange(first, last, value);
+
+    sectorsChanged(ring, first, last + 1);
+    reportChanges(ring, first, last);
+}
+
+void MultiRingSlider::setSectorValue(int ring, int index, int value){
+    DividerModel& model = rings[ring].model;
+    if (value == model.sectorValue(index)) return;
+    model.setSectorCollapsed(index, false);
+
+    int divider, divider_value;
+    model.sectorDivider(index, value, divider, divider_value);
+    setDividerValue(ring, divider, divider_value);
+}
+
+void MultiRingSlider::reportChanges(int ring, int first, int last){
+    rings[ring].model.reportChanges(first, last,
+        [this, ring](int index, int value){emit dividerValueChanged(ring, index, value);},
+        [this, ring](int index, int value){emit sectorValueChanged(ring, index, value);});
+}
+
+void MultiRingSlider::sectorsChanged(int ring, int first, int last){
+    const Ring& current = rings[ring];
+    for (int child : current.children){
+        if (rings[child].parent_sector >= first && rings[child].parent_sector <= last){
+            updateSpans(child);
+        }
+    }
+
+    /* The moved sectors cover the same angles before and after, so only that
+     * part of this level and the levels outside of it has to be rendered again */
+    if (!layer_dirty){
+        if (dirty_ranges.size() == MAX_DIRTY_RANGES){
+            layer_dirty = true;
+        } else {
+            dirty_ranges.push_back({current.level, sectorStart(ring, first), sectorEnd(ring, last)});
+        }
+    }
+    update();
+}
+
+void MultiRingSlider::updateSpans(int ring){
+    Ring& current = rings[ring];
+
+    if (current.parent_ring < 0){
+        current.start_angle = 0;
+        current.span_angle = ANGLE_TICKS_IN_CIRCLE;
+    } else {
+        current.start_angle = sectorStart(current.parent_ring, current.parent_sector);
+        current.span_angle = sectorEnd(current.parent_ring, current.parent_sector) - current.start_angle;
+    }
+
+    for (int child : current.children){
+        updateSpans(child);
+    }
+}
+
+QColor MultiRingSlider::sectorColor(int ring, int index) const{
+    const Ring& current = rings[ring];
+    if (current.parent_ring < 0){
+        return piechart_palette[(ring + index)%piechart_palette.size()];
+    }
+
+    /* Shades of the parent colour, alternating so neighbours stay distinguishable */
+    QColor parent_color = sectorColor(current.parent_ring, current.parent_sector);
+    return (index%2 == 0)? parent_color.lighter(115) : parent_color.darker(115);
+}
+
+int MultiRingSlider::radius() const{
+    return std::min(width(),height())/2 - HANDLE_SIZE/2;
+}
+
+qreal MultiRingSlider::innerRadius(int level) const{
+    qreal hole = radius()/4.0;
+    qreal band = (radius() - hole)/std::max(numberOfLevels(), 1);
+    return hole + level*band;
+}
+
+qreal MultiRingSlider::outerRadius(int level) const{
+    return innerRadius(level + 1);
+}
+
+qreal MultiRingSlider::dividerAngle(int ring, int index) const{
+    const Ring& current = rings[ring];
+    return current.start_angle + current.span_angle*current.model.dividerValue(index)/current.model.total();
+}
+
+qreal MultiRingSlider::sectorStart(int ring, int sector) const{
+    return (sector == 0)? rings[ring].start_angle : dividerAngle(ring, sector - 1);
+}
+
+qreal MultiRingSlider::sectorEnd(int ring, int sector) const{
+    const Ring& current = rings[ring];
+    return (sector == current.model.numberOfDividers())? current.start_angle + current.span_angle
+                                                       : dividerAngle(ring, sector);
+}
+
+int MultiRingSlider::angleToValue(int ring, qreal angle) const{
+    const Ring& current = rings[ring];
+
+    qreal relative_angle = std::fmod(angle - current.start_angle + ANGLE_TICKS_IN_CIRCLE, ANGLE_TICKS_IN_CIRCLE);
+    if (current.span_angle <= 0){
+        return 0;
+    }
+
+    /* Outside of the parent sector, snap to the closest end */
+    if (relative_angle > current.span_angle){
+        return (relative_angle - current.span_angle < ANGLE_TICKS_IN_CIRCLE - relative_angle)? current.model.total() : 0;
+    }
+    return static_cast<int>(round(relative_angle*current.model.total()/current.span_angle));
+}
+
+QPointF MultiRingSlider::angleToPosition(qreal angle, qreal radius) const{
+    qreal real_angle = -angle * 2*M_PI/ANGLE_TICKS_IN_CIRCLE;
+    return pieCentre() + QPointF(radius*cos(real_angle), radius*sin(real_angle));
+}
+
+qreal MultiRingSlider::positionToAngle(QPoint pos) const{
+    QPointF vec = pos - pieCentre();
+    qreal real_angle = std::atan2(-vec.y(), vec.x());
+    if (real_angle < 0){
+        real_angle += 2*M_PI;
+    }
+    return real_angle*ANGLE_TICKS_IN_CIRCLE/(2*M_PI);
+}
+
+int MultiRingSlider::levelAt(QPoint pos) const{
+    QPointF vec = pos - pieCentre();
+    qreal distance = std::hypot(vec.x(), vec.y());
+
+    if (numberOfLevels() == 0 || distance < innerRadius(0) || distance > radius()){
+        return -1;
+    }
+    qreal band = outerRadius(0) - innerRadius(0);
+    return std::min(static_cast<int>((distance - innerRadius(0))/band), numberOfLevels() - 1);
+}
+
+int MultiRingSlider::ringAt(int level, qreal angle) const{
+    for (int ring : rings_by_level[level]){
+        const Ring& current = rings[ring];
+        qreal relative_angle = std::fmod(angle - current.start_angle + ANGLE_TICKS_IN_CIRCLE, ANGLE_TICKS_IN_CIRCLE);
+        if (relative_angle < current.span_angle){
+            return ring;
+        }
+    }
+    return -1;
+}
+
+int MultiRingSlider::dividerAt(int ring, QPoint pos) const{
+    const DividerModel& model = rings[ring].model;
+    if (model.numberOfDividers() == 0) return -1;
+
+    qreal angle = positionToAngle(pos);
+    int value = angleToValue(ring, angle);
+
+    /* Binary search for the first divider at or above value, the closest
+     * divider is either that one or the one before */
+    int low = 0;
+    int high = model.numberOfDividers();
+    while (low < high){
+        int middle = (low + high)/2;
+        if (model.dividerValue(middle) < value){
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    QPointF vec = pos - pieCentre();
+    qreal mouse_radius = std::hypot(vec.x(), vec.y());
+
+    int closest = -1;
+    qreal closest_distance = HANDLE_SIZE/2;
+    for (int index = std::max(low - 1, 0); index <= std::min(low, model.numberOfDividers() - 1); ++index){
+        qreal difference = std::fabs(angle - dividerAngle(ring, index));
+        difference = std::min(difference, ANGLE_TICKS_IN_CIRCLE - difference);
+
+        qreal arc_distance = difference*2*M_PI/ANGLE_TICKS_IN_CIRCLE*mouse_radius;
+        if (arc_distance < closest_distance){
+            closest = index;
+            closest_distance = arc_distance;
+        }
+    }
+    return closest;
+}
+
+void MultiRingSlider::mousePressEvent(QMouseEvent *event){
+    if (event->button() != Qt::LeftButton) return;
+
+    /* Dispatch by radius to a level, then by angle to the ring covering it */
+    int level = levelAt(event->pos());
+    if (level < 0) return;
+
+    int ring = ringAt(level, positionToAngle(event->pos()));
+    if (ring < 0) return;
+
+    int divider = dividerAt(ring, event->pos());
+    if (divider < 0) return;
+
+    pressed_ring = ring;
+    pressed_divider = divider;
+    update();
+}
+
+void MultiRingSlider::mouseMoveEvent(QMouseEvent *event){
+    if (pressed_ring < 0) return;
+
+    const DividerModel& model = rings[pressed_ring].model;
+    int current = model.dividerValue(pressed_divider);
+    int value = angleToValue(pressed_ring, positionToAngle(event->pos()));
+
+    /* Avoid jumping across zero on full rings */
+    if (rings[pressed_ring].parent_ring < 0 && std::abs(value - current) > model.total()/2){
+        value = (value > current)? model.dividerMinimum(pressed_divider) : model.dividerMaximum(pressed_divider);
+    }
+
+    /* Of dividers stacked on the same value, move the one that is free in the direction of movement */
+    while (value > current && pressed_divider < model.numberOfDividers() - 1 &&
+           model.dividerValue(pressed_divider + 1) == current){
+        ++pressed_divider;
+    }
+    while (value < current && pressed_divider > 0 && model.dividerValue(pressed_divider - 1) == current){
+        --pressed_divider;
+    }
+
+    setDividerValue(pressed_ring, pressed_divider, value);
+}
+
+void MultiRingSlider::mouseReleaseEvent(QMouseEvent *event){
+    if (event->button() != Qt::LeftButton || pressed_ring < 0) return;
+
+    pressed_ring = -1;
+    pressed_divider = -1;
+    update();
+}
+
+void MultiRingSlider::resizeEvent(QResizeEvent *event){
+    layer_dirty = true;
+    QWidget::resizeEvent(event);
+}
+
+bool anglesOverlap(qreal start1, qreal end1, qreal start2, qreal end2, int ticks_in_circle){
+    for (int turn = -1; turn <= 1; ++turn){
+        qreal shift = turn*ticks_in_circle;
+        if (start1 <= end2 + shift && start2 + shift <= end1){
+            return true;
+        }
+    }
+    return false;
+}
+
+void MultiRingSlider::drawRing(QPainter& painter, int ring, qreal start_angle, qreal end_angle) const{
+    const Ring& current = rings[ring];
+    qreal inner = innerRadius(current.level);
+    qreal outer = outerRadius(current.level);
+    QRectF inner_envelope(pieCentre() - QPointF(inner, inner), QSizeF(2*inner, 2*inner));
+    QRectF outer_envelope(pieCentre() - QPointF(outer, outer), QSizeF(2*outer, 2*outer));
+
+    /* Sectors as annular wedges. Without outlines to avoid ugly double lines */
+    for (int sector = 0; sector < current.model.numberOfSectors(); ++sector){
+        qreal start = sectorStart(ring, sector);
+        qreal end = sectorEnd(ring, sector);
+        if (end <= start || !anglesOverlap(start, end, start_angle, end_angle, ANGLE_TICKS_IN_CIRCLE)) continue;
+
+        QPainterPath wedge;
+        wedge.arcMoveTo(outer_envelope, start/16);
+        wedge.arcTo(outer_envelope, start/16, (end - start)/16);
+        wedge.arcTo(inner_envelope, end/16, -(end - start)/16);
+        wedge.closeSubpath();
+        painter.fillPath(wedge, sectorColor(ring, sector));
+    }
+
+    /* Start and divider lines */
+    painter.setPen(QPen(Qt::black, 0, Qt::SolidLine, Qt::FlatCap));
+    for (int index = -1; index < current.model.numberOfDividers(); ++index){
+        qreal angle = (index < 0)? current.start_angle : dividerAngle(ring, index);
+        if (anglesOverlap(angle, angle, start_angle, end_angle, ANGLE_TICKS_IN_CIRCLE)){
+            painter.drawLine(angleToPosition(angle, inner), angleToPosition(angle, outer));
+        }
+    }
+}
+
+void MultiRingSlider::drawOutlines(QPainter& painter) const{
+    painter.setPen(QPen(Qt::black, 0, Qt::SolidLine, Qt::FlatCap));
+    painter.setBrush(Qt::NoBrush);
+
+    for (int level = 0; level <= numberOfLevels(); ++level){
+        qreal level_radius = innerRadius(level);
+        painter.drawEllipse(QRectF(pieCentre() - QPointF(level_radius, level_radius),
+                                   QSizeF(2*level_radius, 2*level_radius)));
+    }
+}
+
+void MultiRingSlider::renderLayer(){
+    layer_dirty = false;
+    dirty_ranges.clear();
+
+    ring_layer = QPixmap(size()*devicePixelRatioF());
+    ring_layer.setDevicePixelRatio(devicePixelRatioF());
+    ring_layer.fill(Qt::transparent);
+
+    QPainter painter(&ring_layer);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    for (int ring = 0; ring < numberOfRings(); ++ring){
+        drawRing(painter, ring, 0, ANGLE_TICKS_IN_CIRCLE);
+    }
+    drawOutlines(painter);
+}
+
+void MultiRingSlider::renderRange(const DirtyRange& range){
+    /* Widen the range by a few pixels so lines on its edges are drawn whole,
+     * the neighbours reaching into the margin are drawn again as well */
+    const qreal margin = 2;
+    qreal inner = std::max(innerRadius(range.level) - margin, 0.0);
+    qreal outer = radius() + margin;
+    qreal angle_margin = margin/std::max(inner, 1.0) * ANGLE_TICKS_IN_CIRCLE/(2*M_PI);
+
+    qreal start = range.start_angle - angle_margin;
+    qreal end = range.end_angle + angle_margin;
+
+    QRectF inner_envelope(pieCentre() - QPointF(inner, inner), QSizeF(2*inner, 2*inner));
+    QRectF outer_envelope(pieCentre() - QPointF(outer, outer), QSizeF(2*outer, 2*outer));
+
+    QPainterPath clip;
+    if (end - start >= ANGLE_TICKS_IN_CIRCLE){
+        clip.addEllipse(outer_envelope);
+        clip.addEllipse(inner_envelope);
+    } else {
+        clip.arcMoveTo(outer_envelope, start/16);
+        clip.arcTo(outer_envelope, start/16, (end - start)/16);
+        clip.arcTo(inner_envelope, end/16, -(end - start)/16);
+        clip.closeSubpath();
+    }
+
+    QPainter painter(&ring_layer);
+    painter.setClipPath(clip);
+    painter.setCompositionMode(QPainter::CompositionMode_Clear);
+    painter.fillRect(rect(), Qt::transparent);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    for (int level = std::max(range.level - 1, 0); level < numberOfLevels(); ++level){
+        for (int ring : rings_by_level[level]){
+            const Ring& current = rings[ring];
+            if (anglesOverlap(current.start_angle, current.start_angle + current.span_angle,
+                              start, end, ANGLE_TICKS_IN_CIRCLE)){
+                drawRing(painter, ring, start, end);
+            }
+        }
+    }
+    drawOutlines(painter);
+}
+
+void MultiRingSlider::paintEvent(QPaintEvent *event){
+    QStyleOption opt;
+    opt.init(this);
+    QPainter painter(this);
+    painter.setClipRegion(event->region());
+
+    style()->drawPrimitive(QStyle::PE_Widget, &opt, &painter, this);
+
+    if (layer_dirty){
+        renderLayer();
+    }
+    for (const DirtyRange& range : dirty_ranges){
+        renderRange(range);
+    }
+    dirty_ranges.clear();
+    painter.drawPixmap(0, 0, ring_layer);
+
+    /* Only the grabbed divider gets a handle, the lines themselves are the grab targets */
+    if (pressed_ring >= 0){
+        const Ring& current = rings[pressed_ring];
+        qreal handle_radius = (innerRadius(current.level) + outerRadius(current.level))/2;
+        QPointF centre = angleToPosition(dividerAngle(pressed_ring, pressed_divider), handle_radius);
+
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setBrush(palette().mid());
+        painter.setPen(QPen(palette().shadow(), 0, Qt::SolidLine));
+        painter.drawEllipse(centre, HANDLE_SIZE/2, HANDLE_SIZE/2);
+    }
+}
@@ -25,29 +25,46 @@
 #include <QtMath>
 
 #include <QPainter>
+#include <QPainterPath>
 #include <QStyleOption>
 
 #include <QMouseEvent>
 #include <QWheelEvent>
 
+#include <QDataStream>
+#include <QElapsedTimer>
+
+#include <algorithm>
+
 qreal angleBetweenVectors(const QPointF& vec1, const QPointF& vec2);
 qreal distance(const QPointF& first, const QPointF& second);
+qreal angularWidth(qreal half_extent, qreal radius, int ticks_in_circle);
 
 PieChartSlider::PieChartSlider(int number_of_dividers, int total, QWidget* parent)
     : AbstractDividerSlider(number_of_dividers, total, parent)
 {
     setMinimumSize(100,100);
 
-    //Color Palette by Sasha Trubetskoy, https://sashat.me/2017/01/11/list-of-20-simple-distinct-colors/
-    piechart_palette = {
-        "#e6194B", "#3cb44b", "#ffe119", "#4363d8", "#f58231",
-        "#911eb4", "#42d4f4", "#f032e6", "#bfef45", "#fabebe",
-        "#469990", "#e6beff", "#9A6324", "#fffac8", "#800000",
-        "#aaffc3", "#808000", "#ffd8b1", "#000075", "#a9a9a9"};
+    piechart_palette = SectorPalettes::palette(SectorPalettes::DEFAULT_PALETTE);
 
     sector_handles.fill(SectorHandle(),numberOfSectors());
     sector_handles.back().angle = ANGLE_TICKS_IN_CIRCLE;
 
+    sector_labels.resize(numberOfSectors());
+    zero_handle.radius_offset = -radius()/2.0;
+
+    idle_timer.setSingleShot(true);
+    idle_timer.setInterval(250);
+    connect(&idle_timer, &QTimer::timeout, this, &PieChartSlider::finishInteraction);
+
+    wheel_timer.setSingleShot(true);
+    wheel_timer.setInterval(16);
+    connect(&wheel_timer, &QTimer::timeout, this, &PieChartSlider::flushWheel);
+
+    wheel_burst_timer.setSingleShot(true);
+    wheel_burst_timer.setInterval(500);
+    connect(&wheel_burst_timer, &QTimer::timeout, this, &PieChartSlider::endWheelBurst);
+
     for (int i = 0; i < numberOfDividers(); ++i){
         divider_handles.push_back(DividerHandle());
         moveHandles(i, dividerValue(i));
@@ -61,6 +78,187 @@ PieChartSlider::PieChartSlider(int number_of_dividers, int total, QWidget* paren
 void PieChartSlider::moveHandles(int index, int value){
     divider_handles[index].angle = valueToAngle(value);
     sector_handles[index].angle = divider_handles[index].angle;
+    labels_dirty = true;
+    pie_layer_dirty = true;
+}
+
+void PieChartSlider::setZeroAngle(int angle){
+    angle %= ANGLE_TICKS_IN_CIRCLE;
+    if (angle < 0){
+        angle += ANGLE_TICKS_IN_CIRCLE;
+    }
+    if (angle == zero_angle) return;
+
+    /* Only the painter rotation changes, the cached layer, handles and labels are reused */
+    zero_angle = angle;
+    emit zeroAngleChanged(angle);
+    update();
+}
+
+void PieChartSlider::rebuildHandles(){
+    /* Edits were dropped by restoreState, so a drag or wheel burst in progress ends here */
+    mouse_edit = false;
+    zero_handle.is_pressed = false;
+
+    wheel_timer.stop();
+    wheel_burst_timer.stop();
+    wheel_burst = false;
+    wheel_accumulator = 0;
+    wheel_angle = 0;
+    wheel_sector = -1;
+
+    divider_handles.fill(DividerHandle(), numberOfDividers());
+    sector_handles.fill(SectorHandle(), numberOfSectors());
+    sector_handles.back().angle = ANGLE_TICKS_IN_CIRCLE;
+    sector_labels.resize(numberOfSectors());
+    updateLabelMargin();
+
+    for (int index = 0; index < numberOfDividers(); ++index){
+        divider_handles[index].angle = valueToAngle(dividerValue(index));
+        sector_handles[index].angle = divider_handles[index].angle;
+    }
+
+    /* Same stacking as updateSectorHandels, in a single pass since the angles are sorted */
+    int zero_level = 0;
+    int current_level = 0;
+    qreal prev_angle = -1;
+    for (int index = 0; index < numberOfSectors(); ++index){
+        SectorHandle& handle = sector_handles[index];
+        handle.visible = (sectorValue(index) == 0);
+        if (!handle.visible) continue;
+
+        if (handle.angle == 0 || handle.angle == ANGLE_TICKS_IN_CIRCLE){
+            handle.collapse_level = zero_level++;
+        } else {
+            current_level = (handle.angle == prev_angle)? current_level : 0;
+            handle.collapse_level = current_level++;
+            prev_angle = handle.angle;
+        }
+    }
+
+    labels_dirty = true;
+    pie_layer_dirty = true;
+}
+
+void PieChartSlider::writeState(QDataStream& stream) const{
+    stream << static_cast<qint32>(zero_angle) << static_cast<qint32>(palette_id);
+}
+
+bool PieChartSlider::readState(QDataStream& stream){
+    /* Snapshots saved from the base class have no part of their own */
+    if (stream.atEnd()) return true;
+
+    qint32 angle, id;
+    stream >> angle >> id;
+    if (stream.status() != QDataStream::Ok) return false;
+
+    /* Set directly, as a restore only emits stateRestored */
+    zero_angle = (angle%ANGLE_TICKS_IN_CIRCLE + ANGLE_TICKS_IN_CIRCLE)%ANGLE_TICKS_IN_CIRCLE;
+    setPiechartPalette(id);
+    return true;
+}
+
+void PieChartSlider::setPiechartPalette(int id){
+    if (!SectorPalettes::contains(id)) return;
+
+    piechart_palette = SectorPalettes::palette(id);
+    palette_id = id;
+    pie_layer_dirty = true;
+    update();
+}
+
+void PieChartSlider::setSectorLabel(int index, const QString& label){
+    if (label == sector_labels[index].text.text()) return;
+
+    sector_labels[index].text.setTextFormat(Qt::PlainText);
+    sector_labels[index].text.setText(label);
+    sector_labels[index].text.prepare(QTransform(), font());
+
+    labels_dirty = true;
+    updateLabelMargin();
+    update();
+}
+
+void PieChartSlider::updateLabelMargin(){
+    /* Room for the largest label outside of the rim, so outside labels stay in the widget at any rotation */
+    qreal margin = 0;
+    for (const SectorLabel& label : sector_labels){
+        if (!label.text.text().isEmpty()){
+            margin = std::max(margin, std::hypot(label.text.size().width(), label.text.size().height()));
+        }
+    }
+    if (static_cast<int>(std::ceil(margin)) == label_margin) return;
+
+    label_margin = static_cast<int>(std::ceil(margin));
+    zero_handle.radius_offset = -radius()/2.0;
+    labels_dirty = true;
+    pie_layer_dirty = true;
+}
+
+void PieChartSlider::updateLabelLayout(){
+    labels_dirty = false;
+
+    const qreal inner_radius = 0.65*radius();
+    const qreal outer_radius = radius() + DividerHandle::SIZE/2;
+    const qreal widget_radius = std::min(width(), height())/2.0;
+
+    struct Candidate{
+        int index;
+        qreal start;
+        qreal end;
+    };
+    QVector<Candidate> outside;
+
+    for (int index = 0; index < numberOfSectors(); ++index){
+        SectorLabel& label = sector_labels[index];
+        label.visible = false;
+        if (label.text.text().isEmpty() || sectorValue(index) == 0) continue;
+
+        QSizeF size = label.text.size();
+        qreal half_diagonal = std::hypot(size.width(), size.height())/2;
+
+        qreal start_angle = (index == 0)? 0 : divider_handles[index - 1].angle;
+        qreal end_angle = (index == numberOfDividers())? ANGLE_TICKS_IN_CIRCLE : divider_handles[index].angle;
+        qreal mid_angle = (start_angle + end_angle)/2;
+
+        /* Keep the label in its wedge if its bounding circle fits there, also radially */
+        if (half_diagonal <= radius() - inner_radius &&
+                angularWidth(half_diagonal, inner_radius, ANGLE_TICKS_IN_CIRCLE) <= end_angle - start_angle){
+            label.inside = true;
+            label.visible = true;
+            label.centre = localPosition(mid_angle, inner_radius);
+        } else {
+            /* Labels that would leave the widget at some rotation do not take a slot in the sweep */
+            qreal label_radius = outer_radius + half_diagonal;
+            if (label_radius + half_diagonal > widget_radius) continue;
+            qreal half_width = angularWidth(half_diagonal, label_radius, ANGLE_TICKS_IN_CIRCLE)/2;
+
+            label.inside = false;
+            label.centre = localPosition(mid_angle, label_radius);
+            outside.push_back({index, mid_angle - half_width, mid_angle + half_width});
+        }
+    }
+
+    /* Sweep the outside labels by angle, hiding the ones that overlap an already placed
+     * neighbour. The last ones are also checked against the first to handle wrap around */
+    std::sort(outside.begin(), outside.end(), [](const Candidate& a, const Candidate& b)
+        {return a.start + a.end < b.start + b.end;});
+
+    bool any_placed = false;
+    qreal first_start = 0;
+    qreal last_end = 0;
+    for (const Candidate& candidate : outside){
+        if (any_placed && (candidate.start < last_end ||
+                           candidate.end - ANGLE_TICKS_IN_CIRCLE > first_start)){
+            continue;
+        }
+        if (!any_placed){
+            first_start = candidate.start;
+            any_placed = true;
+        }
+        last_end = candidate.end;
+        sector_labels[candidate.index].visible = true;
+    }
 }
 
 void PieChartSlider::updateSectorHandels(int index, int value){
@@ -87,29 +285,80 @@ void PieChartSlider::updateSectorHandels(int index, int value){
     }
 }
 
+void PieChartSlider::setRenderPolicy(RenderPolicy policy){
+    if (policy == render_policy) return;
+
+    render_policy = policy;
+    update();
+}
+
+bool PieChartSlider::isDraft() const{
+    switch (render_policy){
+    case DraftWhileInteracting:
+        return interacting;
+    case DraftAboveSectorCount:
+        return interacting && numberOfSectors() > draft_sector_threshold;
+    default:
+        return false;
+    }
+}
+
+void PieChartSlider::beginInteraction(){
+    idle_timer.stop();
+    interacting = true;
+}
+
+void PieChartSlider::endInteraction(){
+    idle_timer.start();
+}
+
+void PieChartSlider::finishInteraction(){
+    bool was_draft = isDraft();
+    interacting = false;
+
+    /* paintEvent rebuilds the pie layer if it was rendered in draft */
+    if (was_draft){
+        update();
+    }
+}
+
 int PieChartSlider::radius() const{
-    return std::min(width(),height())/2 - DividerHandle::SIZE/2;
+    /* Labels never shrink the pie below half of its full size */
+    int full_radius = std::min(width(),height())/2 - DividerHandle::SIZE/2;
+    return std::max(full_radius - label_margin, full_radius/2);
 }
 
-int PieChartSlider::valueToAngle(int value) const{
-    return (ANGLE_TICKS_IN_CIRCLE*value) / total();
+qreal PieChartSlider::valueToAngle(int value) const{
+    return static_cast<qreal>(ANGLE_TICKS_IN_CIRCLE)*value / total();
 }
 
-int PieChartSlider::angleToValue(int angle) const{
+int PieChartSlider::angleToValue(qreal angle) const{
     /*Round to get better handling when the anglestep between values is large*/
-    return static_cast<int>(round(static_cast<double>(angle*total()) / ANGLE_TICKS_IN_CIRCLE));
+    return static_cast<int>(round(angle*total() / ANGLE_TICKS_IN_CIRCLE));
 }
 
-int PieChartSlider::positionToAngle(QPoint pos) const{
+qreal PieChartSlider::positionToAngle(QPoint pos) const{
     QPointF vec1 = pos - pieCentre();
     QPointF vec2 = angleToPosition(0, radius()) - pieCentre();
     qreal real_angle = angleBetweenVectors(vec1, vec2);
-    return static_cast<int>(round(real_angle*ANGLE_TICKS_IN_CIRCLE/(2*M_PI)));
+    return real_angle*ANGLE_TICKS_IN_CIRCLE/(2*M_PI);
 }
 
-QPointF PieChartSlider::angleToPosition(int angle, qreal radius) const{
-    qreal real_angle = -(zero_angle + angle) * 2*M_PI/ANGLE_TICKS_IN_CIRCLE;
-    return pieCentre() + QPointF(round(radius*cos(real_angle)), round(radius*sin(real_angle)));
+QPointF PieChartSlider::angleToPosition(qreal angle, qreal radius) const{
+    return localPosition(zero_angle + angle, radius);
+}
+
+QPointF PieChartSlider::localPosition(qreal angle, qreal radius) const{
+    qreal real_angle = -angle * 2*M_PI/ANGLE_TICKS_IN_CIRCLE;
+    return pieCentre() + QPointF(radius*cos(real_angle), radius*sin(real_angle));
+}
+
+QTransform PieChartSlider::zeroRotation() const{
+    QTransform rotation;
+    rotation.translate(pieCentre().x(), pieCentre().y());
+    rotation.rotate(-static_cast<qreal>(zero_angle)/16);
+    rotation.translate(-pieCentre().x(), -pieCentre().y());
+    return rotation;
 }
 
 
@@ -121,25 +370,92 @@ qreal angleBetweenVectors(const QPointF& vec1, const QPointF& vec2){
 }
 
 void PieChartSlider::wheelEvent(QWheelEvent *event){
+    int mouse_value = angleToValue(positionToAngle(event->pos()));
     int sector_index = 0;
-    while(sector_index < numberOfDividers() && dividerValue(sector_index) < angleToValue(positionToAngle(event->pos()))){
+    while(sector_index < numberOfDividers() && dividerValue(sector_index) < mouse_value){
           ++sector_index;
     }
-    int delta = angleToValue(event->angleDelta().y()/5);
-    if (delta == 0){
-        delta = (event->angleDelta().y() < 0)? -1 : 1;
+
+    beginInteraction();
+    if (!wheel_burst){
+        beginEdit();
+        wheel_burst = true;
+    }
+    wheel_burst_timer.start();
+
+    if (sector_index != wheel_sector){
+        flushWheel();
+        wheel_accumulator = 0;
+        wheel_angle = 0;
+        wheel_sector = sector_index;
     }
-    setSectorValue(sector_index, sectorValue(sector_index) + delta);
+
+    /* Touchpads report pixels, taken as a distance along the rim. Wheels report eighths
+     * of a degree, high resolution wheels in steps finer than a notch of 120. When a notch
+     * is worth less than a value, every whole notch accumulated moves exactly one value */
+    qreal delta;
+    if (!event->pixelDelta().isNull()){
+        delta = event->pixelDelta().y()/(2*M_PI*radius()) * total();
+    } else if (WHEEL_NOTCH/5.0 * total()/ANGLE_TICKS_IN_CIRCLE >= 1){
+        delta = event->angleDelta().y()/5.0 * total()/ANGLE_TICKS_IN_CIRCLE;
+    } else {
+        wheel_angle += event->angleDelta().y();
+        delta = wheel_angle/WHEEL_NOTCH;
+        wheel_angle %= WHEEL_NOTCH;
+    }
+    wheel_accumulator += delta;
+    if (!wheel_timer.isActive()){
+        wheel_timer.start();
+    }
+    endInteraction();
+}
+
+void PieChartSlider::flushWheel(){
+    wheel_timer.stop();
+
+    /* Only whole values are applied, the remainder is kept for the next frame */
+    int step = static_cast<int>(wheel_accumulator);
+    if (step == 0 || wheel_sector < 0 || wheel_sector >= numberOfSectors()) return;
+
+    wheel_accumulator -= step;
+    setSectorValue(wheel_sector, sectorValue(wheel_sector) + step);
+}
+
+void PieChartSlider::endWheelBurst(){
+    if (!wheel_burst) return;
+
+    flushWheel();
+    wheel_accumulator = 0;
+    wheel_angle = 0;
+    wheel_sector = -1;
+
+    wheel_burst_timer.stop();
+    wheel_burst = false;
+    endEdit();
+}
+
+void PieChartSlider::finishEdits(){
+    endWheelBurst();
+    releaseHandles();
 }
 
 void PieChartSlider::mousePressEvent(QMouseEvent *event){
     if (event->button() != Qt::LeftButton) return;
+    releaseHandles();
     setEmptySectorsCollapsed();
-
+    beginInteraction();
+    beginEdit();
+    mouse_edit = true;
+
+    if (onHandle(zero_handle, event->pos())){
+        zero_handle.is_pressed = true;
+        repaint(repaintRect(zero_handle));
+        return;
+    }
     for (DividerHandle& handle : divider_handles){
         if (onHandle(handle, event->pos())){
             handle.is_pressed = true;
-            repaint(boundingRect(handle).toAlignedRect());
+            repaint(repaintRect(handle));
             return;
         }
     }
@@ -147,7 +463,7 @@ void PieChartSlider::mousePressEvent(QMouseEvent *event){
         if (handle.visible && onHandle(handle, event->pos())){
             handle.is_pressed = true;
             handle_start_angle = handle.angle;
-            repaint(boundingRect(handle).toAlignedRect());
+            repaint(repaintRect(handle));
             return;
         }
     }
@@ -165,7 +481,22 @@ qreal distance(const QPointF& first, const QPointF& second){
     return sqrt(dx*dx + dy*dy);
 }
 
+qreal angularWidth(qreal half_extent, qreal radius, int ticks_in_circle){
+    /* Angle covered by a circle of radius half_extent centred at a distance radius */
+    return 2*std::asin(std::min(half_extent/radius, 1.0)) * ticks_in_circle/(2*M_PI);
+}
+
 void PieChartSlider::mouseMoveEvent(QMouseEvent *event){
+    /* The button was let go without a release reaching this widget */
+    if (!(event->buttons() & Qt::LeftButton)){
+        releaseHandles();
+        return;
+    }
+
+    if (zero_handle.is_pressed){
+        setZeroAngle(zero_angle + static_cast<int>(round(positionToAngle(event->pos()))));
+        return;
+    }
 
     for (int index = 0; index < numberOfSectors(); ++index){
         if (sector_handles[index].is_pressed){
@@ -180,7 +511,7 @@ void PieChartSlider::mouseMoveEvent(QMouseEvent *event){
 }
 
 void PieChartSlider::processSectorMouseInput(int index, QPoint mouse_pos){
-    int angle = angleFromMouse(index, mouse_pos);
+    qreal angle = angleFromMouse(index, mouse_pos);
     if (angle == handle_start_angle) return;
 
     setSectorCollapsed(index, false);
@@ -202,7 +533,7 @@ void PieChartSlider::processSectorMouseInput(int index, QPoint mouse_pos){
     }
 }
 
-int PieChartSlider::angleFromMouse(int index, QPoint mouse_pos) const{
+qreal PieChartSlider::angleFromMouse(int index, QPoint mouse_pos) const{
     int value = angleToValue(positionToAngle(mouse_pos));
 
     int min_index = (index == 0)? index : index - 1;
@@ -235,23 +566,39 @@ int PieChartSlider::stabilizedValue(int min_index, int max_index, int value) con
 
 void PieChartSlider::mouseReleaseEvent(QMouseEvent *event){
     if (event->button() != Qt::LeftButton) return;
+    releaseHandles();
+}
+
+void PieChartSlider::hideEvent(QHideEvent *event){
+    releaseHandles();
+    AbstractDividerSlider::hideEvent(event);
+}
+
+void PieChartSlider::releaseHandles(){
+    if (!mouse_edit) return;
+    mouse_edit = false;
+
     setEmptySectorsCollapsed();
+    endInteraction();
 
-    for (int index = 0; index < numberOfDividers(); ++index){
-        if(divider_handles[index].is_pressed){
-            divider_handles[index].is_pressed = false;
-            repaint(boundingRect(divider_handles[index]).toAlignedRect());
-            break;
+    for (DividerHandle& handle : divider_handles){
+        if (handle.is_pressed){
+            handle.is_pressed = false;
+            repaint(repaintRect(handle));
         }
     }
-
     for (SectorHandle& handle : sector_handles){
         if (handle.is_pressed){
             handle.is_pressed = false;
-            repaint(boundingRect(handle).toAlignedRect());
-            break;
+            repaint(repaintRect(handle));
         }
     }
+    if (zero_handle.is_pressed){
+        zero_handle.is_pressed = false;
+        repaint(repaintRect(zero_handle));
+    }
+
+    endEdit();
 }
 
 void PieChartSlider::setEmptySectorsCollapsed(){
@@ -262,34 +609,73 @@ void PieChartSlider::setEmptySectorsCollapsed(){
     }
 }
 
+void PieChartSlider::resizeEvent(QResizeEvent *event){
+    zero_handle.radius_offset = -radius()/2.0;
+    labels_dirty = true;
+    pie_layer_dirty = true;
+    AbstractDividerSlider::resizeEvent(event);
+}
+
+void PieChartSlider::changeEvent(QEvent *event){
+    if (event->type() == QEvent::FontChange){
+        for (SectorLabel& label : sector_labels){
+            label.text.prepare(QTransform(), font());
+        }
+        labels_dirty = true;
+        updateLabelMargin();
+    }
+    /* No release arrives once another window takes the input */
+    if ((event->type() == QEvent::ActivationChange && !isActiveWindow()) ||
+            (event->type() == QEvent::EnabledChange && !isEnabled())){
+        releaseHandles();
+    }
+    AbstractDividerSlider::changeEvent(event);
+}
+
 QRectF PieChartSlider::boundingRect(const Handle& handle) const{
-    QPointF centre = angleToPosition(handle.angle, radius() + handle.radiusOffset());
+    QPointF centre = localPosition(handle.angle, radius() + handle.radiusOffset());
 
     return QRectF(centre - QPointF(handle.size()/2, handle.size()/2),
                   centre + QPointF(handle.size()/2, handle.size()/2));
 }
 
-void PieChartSlider::paintEvent(QPaintEvent *event){
-    QStyleOption opt;
-    opt.init(this);
-    QPainter painter(this);
-    painter.setClipRegion(event->region());
+QRect PieChartSlider::repaintRect(const Handle& handle) const{
+    return zeroRotation().mapRect(boundingRect(handle)).toAlignedRect().adjusted(-1, -1, 1, 1);
+}
 
-    style()->drawPrimitive(QStyle::PE_Widget, &opt, &painter, this);
+void PieChartSlider::renderPieLayer(){
+    pie_layer_dirty = false;
+    pie_layer_draft = isDraft();
+
+    /* The pixmap is only allocated again when the widget is resized or moved to another screen */
+    QSize layer_size = size()*devicePixelRatioF();
+    if (pie_layer.size() != layer_size || pie_layer.devicePixelRatioF() != devicePixelRatioF()){
+        pie_layer = QPixmap(layer_size);
+        pie_layer.setDevicePixelRatio(devicePixelRatioF());
+    }
+    pie_layer.fill(Qt::transparent);
 
-    painter.setRenderHint(QPainter::Antialiasing);
+    QPainter painter(&pie_layer);
+    painter.setRenderHint(QPainter::Antialiasing, !pie_layer_draft);
+    drawPie(painter);
+}
 
+void PieChartSlider::drawPie(QPainter& painter) const{
     /* Draw the pies. Without outlines to avoid ugly double lines */
     QRect pie_envelope(pieCentre() - QPoint(radius(),radius()), QSize(2*radius(), 2*radius()));
     painter.setPen(Qt::NoPen);
 
-    painter.setBrush(sectorColor(0));
-    painter.drawPie(pie_envelope, zero_angle, divider_handles[0].angle);
-
-    for (int index = 0; index < numberOfDividers(); ++index){
-        int sector = index + 1;
-        painter.setBrush(sectorColor(sector));
-        painter.drawPie(pie_envelope, divider_handles[index].angle + zero_angle, valueToAngle(sectorValue(sector)));
+    /* Pies are built as paths, as drawPie only takes whole ticks */
+    for (int sector = 0; sector < numberOfSectors(); ++sector){
+        qreal start_angle = (sector == 0)? 0 : divider_handles[sector - 1].angle;
+        qreal end_angle = (sector == numberOfDividers())? ANGLE_TICKS_IN_CIRCLE : divider_handles[sector].angle;
+        if (end_angle <= start_angle) continue;
+
+        QPainterPath pie;
+        pie.moveTo(pieCentre());
+        pie.arcTo(pie_envelope, start_angle/16, (end_angle - start_angle)/16);
+        pie.closeSubpath();
+        painter.fillPath(pie, sectorColor(sector));
     }
 
     /* Draw the piechart outline */
@@ -299,23 +685,69 @@ void PieChartSlider::paintEvent(QPaintEvent *event){
 
     /* Paint zero divider if no handle is present */
     if (divider_handles.back().angle != ANGLE_TICKS_IN_CIRCLE && divider_handles[0].angle != 0){
-        painter.setPen(QPen(Qt::black, 0, Qt::SolidLine, Qt::FlatCap));
-        painter.drawLine(pieCentre(), angleToPosition(0, radius()));
+        painter.drawLine(pieCentre(), localPosition(0, radius()));
     }
 
-    /* Draw divider lines and handles. Avoid painting overlaps twice, as it is ugly */
-    int prev_angle = -1;
-    for (DividerHandle handle : divider_handles){
+    /* Draw divider lines. Avoid painting overlaps twice, as it is ugly */
+    qreal prev_angle = -1;
+    for (const DividerHandle& handle : divider_handles){
         if (handle.angle != prev_angle){
-            painter.setPen(QPen(Qt::black, 0, Qt::SolidLine, Qt::FlatCap));
-            painter.drawLine(pieCentre(), angleToPosition(handle.angle, radius()));
+            painter.drawLine(pieCentre(), localPosition(handle.angle, radius()));
+        }
+        prev_angle = handle.angle;
+    }
+}
+
+void PieChartSlider::paintEvent(QPaintEvent *event){
+    QElapsedTimer paint_timer;
+    paint_timer.start();
+
+    QStyleOption opt;
+    opt.init(this);
+    QPainter painter(this);
+    painter.setClipRegion(event->region());
 
+    style()->drawPrimitive(QStyle::PE_Widget, &opt, &painter, this);
+
+    bool draft = isDraft();
+    if (labels_dirty){
+        updateLabelLayout();
+    }
+
+    painter.setRenderHint(QPainter::Antialiasing, !draft);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, !draft);
+
+    /* Everything but the labels is drawn unrotated, the zero angle is a single painter rotation */
+    QTransform rotation = zeroRotation();
+    painter.setTransform(rotation);
+
+    /* While dividers are moving the layer would change every frame, so the pie is drawn
+     * directly and the layer is only rebuilt for frames where the pie stays the same */
+    if (interacting && pie_layer_dirty){
+        drawPie(painter);
+    } else {
+        if (pie_layer_dirty || (pie_layer_draft && !draft)){
+            renderPieLayer();
+        }
+        painter.drawPixmap(0, 0, pie_layer);
+    }
+
+    /* The zero handle is on the zero divider, halfway to the centre */
+    painter.setBrush(zero_handle.is_pressed ? palette().mid() : palette().dark());
+    QPen handle_outline = draft ? QPen(Qt::NoPen) : QPen(palette().shadow(), 0, Qt::SolidLine);
+    painter.setPen(handle_outline);
+    painter.drawEllipse(boundingRect(zero_handle));
+
+    /* Draw divider handles. Avoid painting overlaps twice, as it is ugly */
+    qreal prev_angle = -1;
+    for (const DividerHandle& handle : divider_handles){
+        if (handle.angle != prev_angle){
             if (handle.is_pressed){
                 painter.setBrush(palette().mid());
             } else {
                 painter.setBrush(palette().button());
             }
-            painter.setPen(QPen(palette().shadow(), 0, Qt::SolidLine));
+            painter.setPen(handle_outline);
 
             painter.drawEllipse(boundingRect(handle));
         }
@@ -331,9 +763,27 @@ void PieChartSlider::paintEvent(QPaintEvent *event){
                 painter.setBrush(sectorColor(index));
             }
 
-            painter.setPen(QPen(Qt::black, 0, Qt::SolidLine));
+            painter.setPen(draft ? QPen(Qt::NoPen) : QPen(Qt::black, 0, Qt::SolidLine));
             painter.drawEllipse(boundingRect(sector_handles[index]));
         }
     }
-}
 
+    /* Draw the sector labels upright */
+    painter.resetTransform();
+    for (int index = 0; index < numberOfSectors(); ++index){
+        const SectorLabel& label = sector_labels[index];
+        if (!label.visible) continue;
+
+        QSizeF size = label.text.size();
+        QPointF top_left = rotation.map(label.centre) - QPointF(size.width()/2, size.height()/2);
+
+        if (label.inside){
+            painter.setPen(sectorColor(index).lightness() > 128 ? Qt::black : Qt::white);
+        } else {
+            painter.setPen(palette().windowText().color());
+        }
+        painter.drawStaticText(top_left, label.text);
+    }
+
+    last_paint_time = paint_timer.nsecsElapsed();
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2019  Exargon
+ *
+ * This is part of a widget to provide a slider having multiple
+ * parts with a constant sum.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301, USA.
+ */
+
+
+#include "sectorpalettes.h"
+
+int SectorPalettes::registerPalette(const QVector<QColor>& palette){
+    registry().push_back(palette);
+    return registry().size() - 1;
+}
+
+QVector<QVector<QColor>>& SectorPalettes::registry(){
+    //Color Palette by Sasha Trubetskoy, https://sashat.me/2017/01/11/list-of-20-simple-distinct-colors/
+    static QVector<QVector<QColor>> palettes = {{
+        "#e6194B", "#3cb44b", "#ffe119", "#4363d8", "#f58231",
+        "#911eb4", "#42d4f4", "#f032e6", "#bfef45", "#fabebe",
+        "#469990", "#e6beff", "#9A6324", "#fffac8", "#800000",
+        "#aaffc3", "#808000", "#ffd8b1", "#000075", "#a9a9a9"}};
+    return palettes;
+}